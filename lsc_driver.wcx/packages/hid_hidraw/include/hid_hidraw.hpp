@@ -14,6 +14,7 @@
 #include "hidapi/hidapi.h"
 #include <vector>
 #include <cstdint>
+#include <cstddef>
 
 namespace hid_hidraw {
 
@@ -28,6 +29,9 @@ public:
 
     int sendData(const std::vector<uint8_t>& data);
     int receiveData(std::vector<uint8_t>& data, int timeout = 500);
+    int receiveData(uint8_t* buffer, size_t length, int timeout = 500);
+
+    static constexpr size_t REPORT_SIZE = 64;
 
 private:
     hid_device* device = nullptr;
@@ -54,11 +54,10 @@ namespace hid_hidraw {
             return -1;
         }
 
-        data.resize(64);
-        int res = hid_read_timeout(device, data.data(), data.size(), timeout);
+        data.resize(REPORT_SIZE);
+        int res = receiveData(data.data(), data.size(), timeout);
 
         if (res < 0) {
-            std::cerr << "Failed to read data" << std::endl;
             return -1;
         }
 
@@ -66,4 +65,21 @@ namespace hid_hidraw {
         return res;
     }
 
+    int hid_hidraw::receiveData(uint8_t* buffer, size_t length, int timeout) {
+        if (!device) {
+            std::cerr << "Device is not connected" << std::endl;
+            return -1;
+        }
+
+        // Reads at most one HID report into a caller-owned buffer (no allocation)
+        int res = hid_read_timeout(device, buffer, length, timeout);
+
+        if (res < 0) {
+            std::cerr << "Failed to read data" << std::endl;
+            return -1;
+        }
+
+        return res;
+    }
+
 } // namespace hid_hidraw
@@ -0,0 +1,76 @@
+#ifndef __LSC_FRAME_PARSER_HPP__
+#define __LSC_FRAME_PARSER_HPP__
+
+#if defined(_WIN32) || defined(_WIN64)
+    #ifdef __LSC_SERVOCONTROL_EXPORTS__
+        #define LSC_SERVOCONTROL_API __declspec(dllexport)
+    #else
+        #define LSC_SERVOCONTROL_API __declspec(dllimport)
+    #endif
+#else
+    #define LSC_SERVOCONTROL_API __attribute__((visibility("default")))
+#endif
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+
+namespace lsc_servocontrol {
+
+// Incremental parser for [0x55 0x55 LENGTH CMD PARAMS...] frames: received bytes are appended
+// to a ring buffer, frames split across reports are reassembled and coalesced frames are split.
+// Frames skipped while waiting for a given command are kept in a pending queue.
+class LSC_SERVOCONTROL_API lsc_frame_parser {
+public:
+    static constexpr std::array<uint8_t, 2> HEADER = {0x55, 0x55};
+
+    static constexpr size_t MIN_FRAME_LENGTH = 2;                      // LENGTH byte covers itself + Command
+    static constexpr size_t MAX_FRAME_SIZE = HEADER.size() + 0xFF;     // Header + largest LENGTH value
+    static constexpr size_t RX_BUFFER_SIZE = 512;                      // Power of two, holds > 1 max frame + 1 report
+    static constexpr size_t PENDING_FRAME_COUNT = 8;
+    static constexpr std::chrono::milliseconds PARTIAL_FRAME_TIMEOUT{100};
+
+    static_assert((RX_BUFFER_SIZE & (RX_BUFFER_SIZE - 1)) == 0, "RX_BUFFER_SIZE must be a power of two");
+    static_assert(RX_BUFFER_SIZE >= MAX_FRAME_SIZE, "RX_BUFFER_SIZE too small");
+
+    void push(const uint8_t* data, size_t length, std::chrono::steady_clock::time_point now);
+
+    // Next frame, pending frames first
+    bool extractFrame(std::vector<uint8_t>& frame);
+    // Next frame for expected_cmd, other frames are queued as pending
+    bool extractFrame(std::vector<uint8_t>& frame, uint8_t expected_cmd);
+
+    // Drops an unfinished frame when nothing was received for PARTIAL_FRAME_TIMEOUT
+    bool dropStalePartialFrame(std::chrono::steady_clock::time_point now);
+
+    void clear();
+    size_t bufferedBytes() const;
+    size_t pendingFrames() const;
+
+private:
+    std::array<uint8_t, RX_BUFFER_SIZE> _buffer{};
+    size_t _head = 0;
+    size_t _count = 0;
+    std::chrono::steady_clock::time_point _last_push_time{};
+
+    struct pending_frame {
+        std::array<uint8_t, MAX_FRAME_SIZE> data{};
+        size_t size = 0;
+    };
+    std::array<pending_frame, PENDING_FRAME_COUNT> _pending{};
+    size_t _pending_head = 0;
+    size_t _pending_count = 0;
+
+    bool parseFrame(std::vector<uint8_t>& frame);
+    uint8_t peek(size_t offset) const;
+    void drop(size_t count);
+
+    void queuePending(const std::vector<uint8_t>& frame);
+    void takePending(size_t index, std::vector<uint8_t>& frame);
+};
+
+} // namespace lsc_servocontrol
+
+#endif // __LSC_FRAME_PARSER_HPP__
@@ -14,12 +14,38 @@
 #include <vector>
 #include <array>
 #include <cstdint>
+#include <cstddef>
 #include <tuple>
 #include <map>
+#include <chrono>
+#include <atomic>
 #include "hid_hidraw.hpp"
+#include "lsc_frame_parser.hpp"
 
 namespace lsc_servocontrol {
 
+// Real-time setup applied to the thread performing the HID I/O
+struct LSC_SERVOCONTROL_API realtime_config {
+    int cpu_core = -1;                          // CPU to pin the thread to (-1: keep current affinity)
+    int priority = 80;                          // SCHED_FIFO priority (0: keep current scheduler)
+    // mlockall() current and future pages. Only done with CAP_IPC_LOCK or an unlimited RLIMIT_MEMLOCK,
+    // otherwise later allocations and thread creation would fail once the lock limit is reached.
+    // Once locked, malloc trimming and mmap are disabled for the whole process (cannot be undone).
+    bool lock_memory = false;
+    size_t prefault_stack_size = 512 * 1024;    // Stack bytes touched up front (0: skip)
+    size_t prefault_heap_size = 1024 * 1024;    // Heap bytes touched and kept by malloc, only when memory is locked (0: skip)
+    uint32_t send_period_us = 0;                // Expected interval between moveServo calls, enables jitter stats (0: off)
+};
+
+// Deviation of the actual interval between two successful moveServo sends from send_period_us
+struct LSC_SERVOCONTROL_API jitter_stats {
+    static constexpr size_t BUCKET_COUNT = 16;
+    std::array<uint64_t, BUCKET_COUNT> histogram{};  // Bucket 0: < 1 us, bucket i: [2^(i-1), 2^i) us, last: overflow
+    uint64_t samples = 0;
+    uint64_t max_deviation_us = 0;
+    uint64_t total_deviation_us = 0;
+};
+
 class LSC_SERVOCONTROL_API lsc_servocontrol {
 public:
     explicit lsc_servocontrol();
@@ -31,6 +57,7 @@ public:
 
     bool sendCommand(uint8_t cmd, const std::vector<uint8_t>& params);
     bool receiveResponse(std::vector<uint8_t>& response, int timeout = 500);
+    bool receiveResponse(std::vector<uint8_t>& response, uint8_t expected_cmd, int timeout = 500);
 
     // bool moveServo(const std::vector<std::tuple<uint8_t, uint16_t>>& servos, uint16_t time);
     bool moveServo(const std::vector<std::tuple<uint8_t, double>>& servos, uint16_t time);
@@ -49,13 +76,22 @@ public:
     bool isActionGroupStopped();
     bool isActionGroupComplete(uint8_t& group_id, uint16_t& repetitions);
 
+    // Opt-in, call from the thread driving the servos; returns false if some step was not applied
+    bool enableRealtime(const realtime_config& config);
+    // Safe to call from a monitoring thread; the snapshot is not atomic as a whole
+    jitter_stats getJitterStats() const;
+    // Call from the thread driving the servos
+    void resetJitterStats();
 
 private:
     hid_hidraw::hid_hidraw _hid_hidraw_instance;
 
     static constexpr uint16_t VENDOR_ID = 0x0483;
     static constexpr uint16_t PRODUCT_ID = 0x5750;
-    static constexpr std::array<uint8_t, 2> HEADER = {0x55, 0x55};
+    static constexpr std::array<uint8_t, 2> HEADER = lsc_frame_parser::HEADER;
+    static constexpr size_t MAX_FRAME_SIZE = lsc_frame_parser::MAX_FRAME_SIZE;
+    static_assert(lsc_frame_parser::RX_BUFFER_SIZE >= MAX_FRAME_SIZE + hid_hidraw::hid_hidraw::REPORT_SIZE, "RX_BUFFER_SIZE too small");
+    static constexpr int ANY_CMD = -1;
 
     static constexpr uint8_t CMD_SERVO_MOVE = 0x03;
     static constexpr uint8_t CMD_GET_BATTERY_VOLTAGE = 0x0F;
@@ -72,7 +108,32 @@ private:
     static uint16_t radiansToPosition(double radians);
     static double positionToRadians(uint16_t position);
 
-    std::vector<uint8_t> buildCommandPacket(uint8_t cmd, const std::vector<uint8_t>& params);
+    void buildCommandPacket(uint8_t cmd, const std::vector<uint8_t>& params, std::vector<uint8_t>& packet);
+
+    // Preallocated so that sending a move does not allocate
+    std::vector<uint8_t> _tx_params;
+    std::vector<uint8_t> _tx_packet;
+
+    uint32_t _send_period_us = 0;
+    std::chrono::steady_clock::time_point _last_send_time{};
+
+    // Single writer (sending thread), lock-free readers (getJitterStats)
+    struct jitter_counters {
+        std::array<std::atomic<uint64_t>, jitter_stats::BUCKET_COUNT> histogram{};
+        std::atomic<uint64_t> samples{0};
+        std::atomic<uint64_t> max_deviation_us{0};
+        std::atomic<uint64_t> total_deviation_us{0};
+    };
+    jitter_counters _jitter_counters;
+
+    void recordSendTime(std::chrono::steady_clock::time_point now);
+    static bool canLockMemory();
+
+    // HID reports are read into _rx_report and reassembled into frames by _rx_parser
+    std::array<uint8_t, hid_hidraw::hid_hidraw::REPORT_SIZE> _rx_report{};
+    lsc_frame_parser _rx_parser;
+
+    bool receiveFrame(std::vector<uint8_t>& frame, int expected_cmd, std::chrono::steady_clock::time_point deadline, bool blocking);
 };
 
 } // namespace lsc_servocontrol
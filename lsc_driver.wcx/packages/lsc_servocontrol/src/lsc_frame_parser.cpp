@@ -0,0 +1,151 @@
+#include <iostream>
+#include <algorithm>
+#include "lsc_frame_parser.hpp"
+
+namespace lsc_servocontrol {
+
+    void lsc_frame_parser::push(const uint8_t* data, size_t length, std::chrono::steady_clock::time_point now) {
+        for (size_t i = 0; i < length; ++i) {
+            // Buffer full: the oldest bytes cannot belong to a valid frame anymore
+            if (_count == _buffer.size()) {
+                drop(1);
+            }
+
+            _buffer[(_head + _count) & (RX_BUFFER_SIZE - 1)] = data[i];
+            ++_count;
+        }
+
+        _last_push_time = now;
+    }
+
+    bool lsc_frame_parser::extractFrame(std::vector<uint8_t>& frame) {
+        if (_pending_count > 0) {
+            takePending(0, frame);
+            return true;
+        }
+
+        return parseFrame(frame);
+    }
+
+    bool lsc_frame_parser::extractFrame(std::vector<uint8_t>& frame, uint8_t expected_cmd) {
+        // The expected reply may already have been queued while waiting for another command
+        for (size_t i = 0; i < _pending_count; ++i) {
+            if (_pending[(_pending_head + i) % PENDING_FRAME_COUNT].data[3] == expected_cmd) {
+                takePending(i, frame);
+                return true;
+            }
+        }
+
+        while (parseFrame(frame)) {
+            if (frame[3] == expected_cmd) {
+                return true;
+            }
+
+            // Keep notifications for the next caller instead of losing them
+            queuePending(frame);
+        }
+
+        return false;
+    }
+
+    bool lsc_frame_parser::dropStalePartialFrame(std::chrono::steady_clock::time_point now) {
+        if (_count == 0 || now - _last_push_time < PARTIAL_FRAME_TIMEOUT) {
+            return false;
+        }
+
+        // Everything left belongs to the unfinished frame, a partial resync could match header bytes in its data
+        std::cout << "Dropping " << _count << " bytes of truncated frame" << std::endl;
+        drop(_count);
+        return true;
+    }
+
+    void lsc_frame_parser::clear() {
+        _head = 0;
+        _count = 0;
+        _pending_head = 0;
+        _pending_count = 0;
+    }
+
+    size_t lsc_frame_parser::bufferedBytes() const {
+        return _count;
+    }
+
+    size_t lsc_frame_parser::pendingFrames() const {
+        return _pending_count;
+    }
+
+    bool lsc_frame_parser::parseFrame(std::vector<uint8_t>& frame) {
+        while (_count >= HEADER.size()) {
+            // Resynchronize on the header after garbage or report padding
+            if (peek(0) != HEADER[0] || peek(1) != HEADER[1]) {
+                drop(1);
+                continue;
+            }
+
+            if (_count < HEADER.size() + 1) {
+                return false; // Wait for the LENGTH byte
+            }
+
+            size_t length = peek(2);
+            if (length < MIN_FRAME_LENGTH) {
+                drop(1); // Not a real header, skip it
+                continue;
+            }
+
+            size_t frameSize = HEADER.size() + length; // Header + LENGTH bytes (Length, Command, Params)
+            if (_count < frameSize) {
+                return false; // Wait for the rest of the frame
+            }
+
+            frame.resize(frameSize);
+            for (size_t i = 0; i < frameSize; ++i) {
+                frame[i] = peek(i);
+            }
+
+            drop(frameSize);
+            return true;
+        }
+
+        // A lone byte can only be kept if it may start a header
+        if (_count == 1 && peek(0) != HEADER[0]) {
+            drop(1);
+        }
+
+        return false;
+    }
+
+    uint8_t lsc_frame_parser::peek(size_t offset) const {
+        return _buffer[(_head + offset) & (RX_BUFFER_SIZE - 1)];
+    }
+
+    void lsc_frame_parser::drop(size_t count) {
+        count = std::min(count, _count);
+        _head = (_head + count) & (RX_BUFFER_SIZE - 1);
+        _count -= count;
+    }
+
+    void lsc_frame_parser::queuePending(const std::vector<uint8_t>& frame) {
+        if (_pending_count == PENDING_FRAME_COUNT) {
+            std::cout << "Pending frame queue full, dropping oldest frame" << std::endl;
+            _pending_head = (_pending_head + 1) % PENDING_FRAME_COUNT;
+            --_pending_count;
+        }
+
+        pending_frame& slot = _pending[(_pending_head + _pending_count) % PENDING_FRAME_COUNT];
+        std::copy(frame.begin(), frame.end(), slot.data.begin());
+        slot.size = frame.size();
+        ++_pending_count;
+    }
+
+    void lsc_frame_parser::takePending(size_t index, std::vector<uint8_t>& frame) {
+        const pending_frame& slot = _pending[(_pending_head + index) % PENDING_FRAME_COUNT];
+        frame.assign(slot.data.begin(), slot.data.begin() + slot.size);
+
+        // Close the gap so that the remaining frames keep their arrival order
+        for (size_t i = index; i + 1 < _pending_count; ++i) {
+            _pending[(_pending_head + i) % PENDING_FRAME_COUNT] = _pending[(_pending_head + i + 1) % PENDING_FRAME_COUNT];
+        }
+        --_pending_count;
+    }
+
+} // namespace lsc_servocontrol
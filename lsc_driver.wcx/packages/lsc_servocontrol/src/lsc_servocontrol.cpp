@@ -1,11 +1,30 @@
 #include <iostream>
 #include <cmath>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#ifdef __linux__
+    #include <pthread.h>
+    #include <sched.h>
+    #include <sys/mman.h>
+    #include <malloc.h>
+    #include <alloca.h>
+    #include <unistd.h>
+    #include <sys/resource.h>
+    #include <linux/capability.h>
+    #include <fstream>
+    #include <string>
+#endif
 #include "lsc_servocontrol.hpp"
 
 namespace lsc_servocontrol {
 
     lsc_servocontrol::lsc_servocontrol() {
         // Constructor
+        _tx_params.reserve(MAX_FRAME_SIZE);
+        _tx_packet.reserve(MAX_FRAME_SIZE);
     }
 
     lsc_servocontrol::~lsc_servocontrol() {
@@ -14,6 +33,8 @@ namespace lsc_servocontrol {
     }
 
     bool lsc_servocontrol::connect() {
+        _rx_parser.clear();
+
         if (_hid_hidraw_instance.openDevice(VENDOR_ID, PRODUCT_ID)) {
             std::cout << "HID Connection established" << std::endl;
             return true;
@@ -25,6 +46,7 @@ namespace lsc_servocontrol {
 
     void lsc_servocontrol::disconnect() {
         _hid_hidraw_instance.closeDevice();
+        _rx_parser.clear();
         std::cout << "HID Connection closed" << std::endl;
     }
 
@@ -38,13 +60,25 @@ namespace lsc_servocontrol {
             return false;
         }
 
-        std::vector<uint8_t> packet = buildCommandPacket(cmd, params);
+        buildCommandPacket(cmd, params, _tx_packet);
+
+        const auto sendTime = std::chrono::steady_clock::now();
 
-        if (_hid_hidraw_instance.sendData(packet) < 0) {
+        if (_hid_hidraw_instance.sendData(_tx_packet) < 0) {
             std::cout << "Failed to send command" << std::endl;
+
+            // A dropped move must not count as a doubled interval on the next one
+            if (cmd == CMD_SERVO_MOVE) {
+                _last_send_time = std::chrono::steady_clock::time_point{};
+            }
             return false;
         }
 
+        // Only the periodic move command is measured, requests like position reads would skew the histogram
+        if (_send_period_us > 0 && cmd == CMD_SERVO_MOVE) {
+            recordSendTime(sendTime);
+        }
+
         return true;
     }
 
@@ -54,27 +88,77 @@ namespace lsc_servocontrol {
             return false;
         }
 
-        response.clear();
-        int bytesRead = _hid_hidraw_instance.receiveData(response, timeout);
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
 
-        if (bytesRead <= 0) {
+        if (!receiveFrame(response, ANY_CMD, deadline, timeout < 0)) {
             std::cout << "Failed to receive response" << std::endl;
             return false;
         }
 
-        if (bytesRead < 2) {
-            std::cout << "Response too short" << std::endl;
+        return true;
+    }
+
+    bool lsc_servocontrol::receiveResponse(std::vector<uint8_t>& response, uint8_t expected_cmd, int timeout) {
+        if (!isConnected()) {
+            std::cout << "HID Connection not established" << std::endl;
             return false;
         }
 
-        if (response[0] != HEADER[0] || response[1] != HEADER[1]) {
-            std::cout << "Invalid response header" << std::endl;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+
+        // Other frames received meanwhile are kept for later calls
+        if (!receiveFrame(response, expected_cmd, deadline, timeout < 0)) {
+            std::cout << "Failed to receive response" << std::endl;
             return false;
         }
 
         return true;
     }
 
+    bool lsc_servocontrol::receiveFrame(std::vector<uint8_t>& frame, int expected_cmd, std::chrono::steady_clock::time_point deadline, bool blocking) {
+        auto extract = [&]() {
+            return expected_cmd == ANY_CMD ? _rx_parser.extractFrame(frame)
+                                           : _rx_parser.extractFrame(frame, static_cast<uint8_t>(expected_cmd));
+        };
+
+        frame.clear();
+
+        // A previous report may already contain the next frame (coalesced frames)
+        if (extract()) {
+            return true;
+        }
+
+        while (true) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            if (remaining.count() < 0) {
+                remaining = std::chrono::milliseconds(0);
+            }
+
+            int readTimeout = blocking ? -1 : static_cast<int>(remaining.count());
+            int bytesRead = _hid_hidraw_instance.receiveData(_rx_report.data(), _rx_report.size(), readTimeout);
+
+            if (bytesRead < 0) {
+                return false;
+            }
+
+            if (bytesRead > 0) {
+                _rx_parser.push(_rx_report.data(), static_cast<size_t>(bytesRead), std::chrono::steady_clock::now());
+
+                // Frames longer than one report are reassembled across reads
+                if (extract()) {
+                    return true;
+                }
+            } else {
+                // Device has nothing more: a frame left unfinished for too long was truncated
+                _rx_parser.dropStalePartialFrame(std::chrono::steady_clock::now());
+            }
+
+            if (!blocking && remaining.count() == 0) {
+                return false;
+            }
+        }
+    }
+
     bool lsc_servocontrol::moveServo(const std::vector<std::tuple<uint8_t, double>>& servos, uint16_t time) {
         if (!isConnected()) {
             std::cout << "HID Connection not established" << std::endl;
@@ -86,22 +170,22 @@ namespace lsc_servocontrol {
             return false;
         }
     
-        std::vector<uint8_t> params;
-        params.push_back(static_cast<uint8_t>(servos.size()));
-        params.push_back(static_cast<uint8_t>(time & 0xFF)); // Time LSB
-        params.push_back(static_cast<uint8_t>((time >> 8) & 0xFF)); // Time MSB
+        _tx_params.clear(); // Reuses the preallocated buffer
+        _tx_params.push_back(static_cast<uint8_t>(servos.size()));
+        _tx_params.push_back(static_cast<uint8_t>(time & 0xFF)); // Time LSB
+        _tx_params.push_back(static_cast<uint8_t>((time >> 8) & 0xFF)); // Time MSB
     
         for (const auto& servo : servos) {
             uint8_t id = std::get<0>(servo);
             double angleRad = std::get<1>(servo); // L'utilisateur donne un angle en radians
             uint16_t position = radiansToPosition(angleRad); // Convertit en position 0-1000
     
-            params.push_back(id);
-            params.push_back(static_cast<uint8_t>(position & 0xFF)); // Position LSB
-            params.push_back(static_cast<uint8_t>((position >> 8) & 0xFF)); // Position MSB
+            _tx_params.push_back(id);
+            _tx_params.push_back(static_cast<uint8_t>(position & 0xFF)); // Position LSB
+            _tx_params.push_back(static_cast<uint8_t>((position >> 8) & 0xFF)); // Position MSB
         }
     
-        return sendCommand(CMD_SERVO_MOVE, params);
+        return sendCommand(CMD_SERVO_MOVE, _tx_params);
     }
     
 
@@ -114,11 +198,16 @@ namespace lsc_servocontrol {
         }
 
         std::vector<uint8_t> response;
-        if (!receiveResponse(response)) {
+        if (!receiveResponse(response, CMD_GET_BATTERY_VOLTAGE)) {
             std::cerr << "[ERREUR] Aucune réponse valide reçue pour la tension de batterie !" << std::endl;
             return false;
         }
 
+        if (response.size() < 6) {
+            std::cerr << "[ERREUR] Réponse de tension de batterie trop courte !" << std::endl;
+            return false;
+        }
+
         // Extraction des valeurs de tension
         voltage = static_cast<uint16_t>(response[4] | (response[5] << 8));
         std::cout << "[INFO] Tension de la batterie : " << voltage << " mV" << std::endl;
@@ -168,12 +257,12 @@ namespace lsc_servocontrol {
     
         // Wait for response
         std::vector<uint8_t> response;
-        if (!receiveResponse(response)) {
+        if (!receiveResponse(response, CMD_MULT_SERVO_POS_READ)) {
             std::cout << "Failed to receive response" << std::endl;
             return positions;
         }
     
-        if (response.size() < 5 || response[3] != CMD_MULT_SERVO_POS_READ) {
+        if (response.size() < 5) {
             std::cout << "Invalid response" << std::endl;
             return positions;
         }
@@ -245,12 +334,12 @@ namespace lsc_servocontrol {
     bool lsc_servocontrol::isActionGroupRunning(uint8_t& group_id, uint16_t& repetitions) {
         std::vector<uint8_t> response;
 
-        if (!receiveResponse(response)) {
+        if (!receiveResponse(response, CMD_ACTION_GROUP_RUN)) {
             std::cout << "Failed to receive response" << std::endl;
             return false;
         }
 
-        if (response.size() != 7 || response[3] != CMD_ACTION_GROUP_RUN) {
+        if (response.size() != 7) {
             std::cout << "Invalid response" << std::endl;
             return false;
         }
@@ -264,12 +353,12 @@ namespace lsc_servocontrol {
     bool lsc_servocontrol::isActionGroupStopped() {
         std::vector<uint8_t> response;
 
-        if (!receiveResponse(response)) {
+        if (!receiveResponse(response, CMD_ACTION_GROUP_STOP)) {
             std::cout << "Failed to receive response" << std::endl;
             return false;
         }
 
-        if (response.size() != 4 || response[3] != CMD_ACTION_GROUP_STOP) {
+        if (response.size() != 4) {
             std::cout << "Invalid response" << std::endl;
             return false;
         }
@@ -285,12 +374,12 @@ namespace lsc_servocontrol {
 
         std::vector<uint8_t> response;
 
-        if (!receiveResponse(response)) {
+        if (!receiveResponse(response, CMD_ACTION_GROUP_COMPLETE)) {
             std::cout << "Failed to receive response" << std::endl;
             return false;
         }
 
-        if (response.size() != 7 || response[3] != CMD_ACTION_GROUP_COMPLETE) {
+        if (response.size() != 7) {
             std::cout << "Invalid response" << std::endl;
             return false;
         }
@@ -312,8 +401,8 @@ namespace lsc_servocontrol {
         return rad;
     }
 
-    std::vector<uint8_t> lsc_servocontrol::buildCommandPacket(uint8_t cmd, const std::vector<uint8_t>& params) {
-        std::vector<uint8_t> packet;
+    void lsc_servocontrol::buildCommandPacket(uint8_t cmd, const std::vector<uint8_t>& params, std::vector<uint8_t>& packet) {
+        packet.clear();
 
         // Add fixed header [0x55, 0x55]
         packet.push_back(HEADER[0]);
@@ -328,8 +417,188 @@ namespace lsc_servocontrol {
 
         // Add parameters if present
         packet.insert(packet.end(), params.begin(), params.end());
+    }
+
+    bool lsc_servocontrol::enableRealtime(const realtime_config& config) {
+        bool applied = true;
+
+        _send_period_us = config.send_period_us;
+        resetJitterStats();
+
+#ifdef __linux__
+        bool memoryLocked = false;
+
+        if (config.lock_memory) {
+            if (!canLockMemory()) {
+                std::cerr << "[WARN] No CAP_IPC_LOCK and RLIMIT_MEMLOCK is limited, memory not locked" << std::endl;
+                applied = false;
+            } else if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+                std::cerr << "[WARN] mlockall failed: " << std::strerror(errno) << ", memory not locked" << std::endl;
+                applied = false;
+            } else {
+                memoryLocked = true;
+
+                // Process-wide: keep malloc from returning memory to the OS or using mmap, so the locked heap stays resident
+                mallopt(M_TRIM_THRESHOLD, -1);
+                mallopt(M_MMAP_MAX, 0);
+            }
+        }
+
+        if (memoryLocked && config.prefault_heap_size > 0) {
+            const long pageSize = sysconf(_SC_PAGESIZE);
+            void* heapBlock = malloc(config.prefault_heap_size);
+            if (heapBlock) {
+                // volatile keeps the compiler from eliding writes that are never read back
+                volatile char* heap = static_cast<volatile char*>(heapBlock);
+                for (size_t i = 0; i < config.prefault_heap_size; i += static_cast<size_t>(pageSize)) {
+                    heap[i] = 0;
+                }
+                free(heapBlock); // Kept by malloc thanks to M_TRIM_THRESHOLD
+            } else {
+                std::cerr << "[WARN] Unable to allocate " << config.prefault_heap_size << " bytes, heap not prefaulted" << std::endl;
+                applied = false;
+            }
+        }
+
+        if (config.prefault_stack_size > 0) {
+            const long pageSize = sysconf(_SC_PAGESIZE);
+            size_t stackSize = config.prefault_stack_size;
+
+            // Never touch more than what is left of this thread's stack, minus a safety margin
+            static constexpr size_t STACK_MARGIN = 64 * 1024;
+            pthread_attr_t attr;
+            if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+                void* stackAddr = nullptr;
+                size_t totalSize = 0;
+                char marker = 0;
+
+                if (pthread_attr_getstack(&attr, &stackAddr, &totalSize) == 0) {
+                    size_t available = static_cast<size_t>(&marker - static_cast<char*>(stackAddr));
+                    size_t usable = available > STACK_MARGIN ? available - STACK_MARGIN : 0;
+
+                    if (stackSize > usable) {
+                        std::cerr << "[WARN] Stack prefault size " << stackSize << " clamped to " << usable << " bytes" << std::endl;
+                        stackSize = usable;
+                    }
+                } else {
+                    std::cerr << "[WARN] Unable to query stack bounds, stack not prefaulted" << std::endl;
+                    stackSize = 0;
+                    applied = false;
+                }
+                pthread_attr_destroy(&attr);
+            } else {
+                std::cerr << "[WARN] Unable to query stack size, stack not prefaulted" << std::endl;
+                stackSize = 0;
+                applied = false;
+            }
 
-        return packet;
+            if (stackSize > 0) {
+                volatile char* stack = static_cast<volatile char*>(alloca(stackSize));
+                for (size_t i = 0; i < stackSize; i += static_cast<size_t>(pageSize)) {
+                    stack[i] = 0;
+                }
+            }
+        }
+
+        if (config.cpu_core >= 0) {
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            CPU_SET(config.cpu_core, &cpuset);
+
+            int res = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+            if (res != 0) {
+                std::cerr << "[WARN] Failed to pin thread to CPU " << config.cpu_core << ": " << std::strerror(res) << std::endl;
+                applied = false;
+            }
+        }
+
+        if (config.priority > 0) {
+            sched_param param{};
+            param.sched_priority = std::clamp(config.priority, sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO));
+
+            int res = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+            if (res != 0) {
+                std::cerr << "[WARN] Failed to set SCHED_FIFO priority " << param.sched_priority << ": " << std::strerror(res)
+                          << ", keeping default scheduler" << std::endl;
+                applied = false;
+            }
+        }
+#else
+        std::cerr << "[WARN] Real-time mode not supported on this platform" << std::endl;
+        applied = false;
+#endif
+
+        std::cout << (applied ? "Real-time mode enabled" : "Real-time mode partially enabled") << std::endl;
+        return applied;
+    }
+
+    bool lsc_servocontrol::canLockMemory() {
+#ifdef __linux__
+        rlimit limit{};
+        if (getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur == RLIM_INFINITY) {
+            return true;
+        }
+
+        // CAP_IPC_LOCK lifts RLIMIT_MEMLOCK, read it from the effective capability set
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.rfind("CapEff:", 0) == 0) {
+                unsigned long long caps = std::stoull(line.substr(7), nullptr, 16);
+                return (caps >> CAP_IPC_LOCK) & 1ULL;
+            }
+        }
+#endif
+        return false;
+    }
+
+    jitter_stats lsc_servocontrol::getJitterStats() const {
+        jitter_stats stats;
+
+        for (size_t i = 0; i < jitter_stats::BUCKET_COUNT; ++i) {
+            stats.histogram[i] = _jitter_counters.histogram[i].load(std::memory_order_relaxed);
+        }
+        stats.samples = _jitter_counters.samples.load(std::memory_order_relaxed);
+        stats.max_deviation_us = _jitter_counters.max_deviation_us.load(std::memory_order_relaxed);
+        stats.total_deviation_us = _jitter_counters.total_deviation_us.load(std::memory_order_relaxed);
+
+        return stats;
+    }
+
+    void lsc_servocontrol::resetJitterStats() {
+        for (auto& bucket : _jitter_counters.histogram) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        _jitter_counters.samples.store(0, std::memory_order_relaxed);
+        _jitter_counters.max_deviation_us.store(0, std::memory_order_relaxed);
+        _jitter_counters.total_deviation_us.store(0, std::memory_order_relaxed);
+        _last_send_time = std::chrono::steady_clock::time_point{};
+    }
+
+    void lsc_servocontrol::recordSendTime(std::chrono::steady_clock::time_point now) {
+        if (_last_send_time == std::chrono::steady_clock::time_point{}) {
+            _last_send_time = now;
+            return;
+        }
+
+        int64_t interval = std::chrono::duration_cast<std::chrono::microseconds>(now - _last_send_time).count();
+        _last_send_time = now;
+
+        uint64_t deviation = static_cast<uint64_t>(std::abs(interval - static_cast<int64_t>(_send_period_us)));
+
+        // Log2 buckets: 0 -> < 1 us, i -> [2^(i-1), 2^i) us
+        size_t bucket = 0;
+        while (bucket < jitter_stats::BUCKET_COUNT - 1 && (deviation >> bucket) != 0) {
+            ++bucket;
+        }
+
+        // Single writer: relaxed read-modify-write is enough and never blocks the send path
+        _jitter_counters.histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+        _jitter_counters.samples.fetch_add(1, std::memory_order_relaxed);
+        _jitter_counters.total_deviation_us.fetch_add(deviation, std::memory_order_relaxed);
+        if (deviation > _jitter_counters.max_deviation_us.load(std::memory_order_relaxed)) {
+            _jitter_counters.max_deviation_us.store(deviation, std::memory_order_relaxed);
+        }
     }
 
 } // namespace lsc_servocontrol
@@ -0,0 +1,121 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include "lsc_frame_parser.hpp"
+
+using lsc_servocontrol::lsc_frame_parser;
+using Clock = std::chrono::steady_clock;
+
+static int failures = 0;
+
+void check(bool condition, const char* name) {
+    std::cout << (condition ? "[OK]   " : "[FAIL] ") << name << "\n";
+    if (!condition) {
+        ++failures;
+    }
+}
+
+void push(lsc_frame_parser& parser, const std::vector<uint8_t>& data, Clock::time_point now = Clock::now()) {
+    parser.push(data.data(), data.size(), now);
+}
+
+std::vector<uint8_t> positionFrame(uint8_t servos) {
+    std::vector<uint8_t> frame = {0x55, 0x55, static_cast<uint8_t>(3 + 3 * servos), 0x15, servos};
+    for (uint8_t id = 1; id <= servos; ++id) {
+        frame.insert(frame.end(), {id, 0x55, 0x55}); // Header bytes inside the payload
+    }
+    return frame;
+}
+
+void testReassembly() {
+    lsc_frame_parser parser;
+    std::vector<uint8_t> frame = positionFrame(30);
+    std::vector<uint8_t> out;
+
+    push(parser, std::vector<uint8_t>(frame.begin(), frame.begin() + 64));
+    check(!parser.extractFrame(out), "reassembly: incomplete frame is not returned");
+
+    push(parser, std::vector<uint8_t>(frame.begin() + 64, frame.end()));
+    check(parser.extractFrame(out) && out == frame, "reassembly: frame split over two reports");
+}
+
+void testCoalesced() {
+    lsc_frame_parser parser;
+    std::vector<uint8_t> out;
+
+    push(parser, {0x55, 0x55, 0x04, 0x0F, 0x10, 0x27, 0x55, 0x55, 0x02, 0x07});
+    check(parser.extractFrame(out) && out.size() == 6 && out[3] == 0x0F, "coalesced: first frame");
+    check(parser.extractFrame(out) && out.size() == 4 && out[3] == 0x07, "coalesced: second frame");
+    check(!parser.extractFrame(out), "coalesced: nothing left");
+}
+
+void testResync() {
+    lsc_frame_parser parser;
+    std::vector<uint8_t> out;
+
+    push(parser, {0x12, 0x55, 0x34, 0x55, 0x55, 0x02, 0x07, 0x00, 0x00, 0x00, 0x00});
+    check(parser.extractFrame(out) && out == std::vector<uint8_t>({0x55, 0x55, 0x02, 0x07}), "resync: garbage before header");
+    check(!parser.extractFrame(out) && parser.bufferedBytes() == 0, "resync: padding discarded");
+}
+
+void testShortLength() {
+    lsc_frame_parser parser;
+    std::vector<uint8_t> out;
+
+    push(parser, {0x55, 0x55, 0x01, 0x55, 0x55, 0x02, 0x07});
+    check(parser.extractFrame(out) && out == std::vector<uint8_t>({0x55, 0x55, 0x02, 0x07}), "length < 2: header skipped");
+}
+
+void testOverflow() {
+    lsc_frame_parser parser;
+    std::vector<uint8_t> out;
+
+    // Unfinished max-size frame followed by more bytes than the buffer holds
+    push(parser, {0x55, 0x55, 0xFF, 0x15});
+    push(parser, std::vector<uint8_t>(lsc_frame_parser::RX_BUFFER_SIZE, 0x00));
+    check(parser.bufferedBytes() <= lsc_frame_parser::RX_BUFFER_SIZE, "overflow: buffer bounded");
+
+    push(parser, {0x55, 0x55, 0x02, 0x07});
+    check(parser.extractFrame(out) && out == std::vector<uint8_t>({0x55, 0x55, 0x02, 0x07}), "overflow: next frame recovered");
+}
+
+void testPending() {
+    lsc_frame_parser parser;
+    std::vector<uint8_t> out;
+
+    push(parser, {0x55, 0x55, 0x05, 0x08, 0x01, 0x02, 0x00, 0x55, 0x55, 0x04, 0x0F, 0x10, 0x27});
+    check(parser.extractFrame(out, 0x0F) && out[3] == 0x0F, "pending: expected reply found");
+    check(parser.pendingFrames() == 1, "pending: notification kept");
+    check(parser.extractFrame(out, 0x08) && out.size() == 7 && out[4] == 0x01, "pending: notification returned later");
+}
+
+void testStalePartial() {
+    lsc_frame_parser parser;
+    std::vector<uint8_t> out;
+    Clock::time_point start = Clock::now();
+
+    push(parser, {0x55, 0x55, 0x0A, 0x15, 0x01}, start);
+    check(!parser.dropStalePartialFrame(start + std::chrono::milliseconds(10)), "partial: recent frame kept");
+
+    push(parser, {0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08}, start + std::chrono::milliseconds(20));
+    check(parser.extractFrame(out) && out.size() == 12, "partial: completed by a late report");
+
+    push(parser, {0x55, 0x55, 0x0A, 0x15, 0x01}, start);
+    check(parser.dropStalePartialFrame(start + lsc_frame_parser::PARTIAL_FRAME_TIMEOUT), "partial: stale frame dropped");
+
+    push(parser, {0x55, 0x55, 0x04, 0x0F, 0x10, 0x27});
+    check(parser.extractFrame(out) && out[3] == 0x0F, "partial: next reply not merged");
+}
+
+int main() {
+    testReassembly();
+    testCoalesced();
+    testResync();
+    testShortLength();
+    testOverflow();
+    testPending();
+    testStalePartial();
+
+    std::cout << (failures == 0 ? "All frame parser checks passed" : "Frame parser checks failed") << "\n";
+    return failures == 0 ? 0 : 1;
+}